@@ -0,0 +1,43 @@
+#include "CountedFramebuffer.hpp"
+
+CCountedFramebuffer::~CCountedFramebuffer() {
+    release();
+}
+
+bool CCountedFramebuffer::alloc(int w, int h, uint32_t format, size_t bytesPerPixel) {
+    release();
+
+    const bool RESULT = CFramebuffer::alloc(w, h, format);
+
+    counted = true;
+    bytes   = (size_t)w * h * bytesPerPixel;
+    s_liveCount++;
+    s_liveBytes += bytes;
+
+    return RESULT;
+}
+
+void CCountedFramebuffer::release() {
+    if (counted) {
+        s_liveCount--;
+        s_liveBytes -= bytes;
+        counted = false;
+        bytes   = 0;
+    }
+
+    CFramebuffer::release();
+}
+
+void CCountedFramebuffer::setBytesPerPixel(size_t bytesPerPixel) {
+    s_liveBytes -= bytes;
+    bytes = (size_t)m_size.x * m_size.y * bytesPerPixel;
+    s_liveBytes += bytes;
+}
+
+size_t CCountedFramebuffer::liveCount() {
+    return s_liveCount;
+}
+
+size_t CCountedFramebuffer::liveBytes() {
+    return s_liveBytes;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <hyprland/src/render/Framebuffer.hpp>
+#include <cstddef>
+
+// CFramebuffer that keeps a tally of every buffer the plugin holds, so leaks show up
+// as counts that don't go back down (see `hyprctl winview:fbstats`).
+// Always hold these by their own type, the base class' alloc/release don't count.
+class CCountedFramebuffer : public CFramebuffer {
+  public:
+    CCountedFramebuffer() = default;
+    ~CCountedFramebuffer();
+
+    CCountedFramebuffer(const CCountedFramebuffer&)            = delete;
+    CCountedFramebuffer& operator=(const CCountedFramebuffer&) = delete;
+
+    bool                 alloc(int w, int h, uint32_t format, size_t bytesPerPixel = 4);
+    void                 release();
+
+    // for when the texture storage is swapped after alloc
+    void                 setBytesPerPixel(size_t bytesPerPixel);
+
+    static size_t        liveCount();
+    static size_t        liveBytes();
+
+  private:
+    bool                 counted = false;
+    size_t               bytes   = 0;
+
+    inline static size_t s_liveCount = 0;
+    inline static size_t s_liveBytes = 0;
+};
@@ -0,0 +1,269 @@
+#include "SnapshotStore.hpp"
+#include <hyprland/src/render/Renderer.hpp>
+#include <hyprland/src/render/OpenGL.hpp>
+#include <hyprland/src/desktop/Window.hpp>
+#include <hyprland/src/Compositor.hpp>
+#include <algorithm>
+
+// snapshots are only ever shown as a tile, this is plenty
+constexpr int SNAPSHOT_WIDTH = 256;
+// a tile's readback is done within a frame or two, no point in asking more often
+constexpr int READBACK_POLL_MS = 4;
+
+// packbits-like: a header word with the top bit set repeats the next pixel (header & 0x7FFF) times,
+// otherwise it's followed by that many literal pixels
+static void encodeRLE(const std::vector<uint16_t>& pixels, std::vector<uint16_t>& out) {
+    out.clear();
+
+    size_t i = 0;
+    while (i < pixels.size()) {
+        size_t run = 1;
+        while (i + run < pixels.size() && pixels[i + run] == pixels[i] && run < 0x7FFF) {
+            run++;
+        }
+
+        if (run > 2) {
+            out.push_back(0x8000 | run);
+            out.push_back(pixels[i]);
+            i += run;
+            continue;
+        }
+
+        // gather literals until the next repeat worth encoding
+        const size_t HEADER = out.size();
+        out.push_back(0);
+        size_t count = 0;
+        while (i < pixels.size() && count < 0x7FFF) {
+            if (i + 2 < pixels.size() && pixels[i] == pixels[i + 1] && pixels[i] == pixels[i + 2])
+                break;
+
+            out.push_back(pixels[i++]);
+            count++;
+        }
+        out[HEADER] = count;
+    }
+
+    out.shrink_to_fit();
+}
+
+static void decodeRLE(const std::vector<uint16_t>& in, std::vector<uint8_t>& rgba) {
+    rgba.clear();
+
+    auto pushPixel = [&rgba](uint16_t p) {
+        const uint8_t R = (p >> 11) & 0x1F, G = (p >> 5) & 0x3F, B = p & 0x1F;
+        rgba.push_back((R << 3) | (R >> 2));
+        rgba.push_back((G << 2) | (G >> 4));
+        rgba.push_back((B << 3) | (B >> 2));
+        rgba.push_back(0xFF);
+    };
+
+    size_t i = 0;
+    while (i < in.size()) {
+        const uint16_t HEADER = in[i++];
+        const size_t   COUNT  = HEADER & 0x7FFF;
+
+        if (HEADER & 0x8000) {
+            if (i >= in.size())
+                break;
+
+            for (size_t j = 0; j < COUNT; ++j) {
+                pushPixel(in[i]);
+            }
+            i++;
+            continue;
+        }
+
+        for (size_t j = 0; j < COUNT && i < in.size(); ++j) {
+            pushPixel(in[i++]);
+        }
+    }
+}
+
+static int pollTimerCallback(void* data) {
+    ((CSnapshotStore*)data)->onPollTimer();
+    return 0;
+}
+
+CSnapshotStore::CSnapshotStore() {
+    pollTimer = wl_event_loop_add_timer(g_pCompositor->m_wlEventLoop, pollTimerCallback, this);
+}
+
+CSnapshotStore::~CSnapshotStore() {
+    if (pollTimer)
+        wl_event_source_remove(pollTimer);
+
+    g_pHyprRenderer->makeEGLCurrent();
+    for (auto& p : pending) {
+        destroy(p);
+    }
+    downscaleFB.release();
+}
+
+CSnapshotStore::SSnapshot* CSnapshotStore::getSnapshot(PHLWINDOW pWindow) {
+    for (auto& s : snapshots) {
+        if (s.pWindow == pWindow)
+            return &s;
+    }
+
+    return nullptr;
+}
+
+bool CSnapshotStore::has(PHLWINDOW pWindow) {
+    return getSnapshot(pWindow);
+}
+
+size_t CSnapshotStore::bytes() const {
+    return totalBytes;
+}
+
+void CSnapshotStore::capture(PHLWINDOW pWindow, CCountedFramebuffer& fb) {
+    if (!fb.isAllocated() || fb.m_size.x <= 0 || fb.m_size.y <= 0)
+        return;
+
+    const Vector2D SIZE = Vector2D{SNAPSHOT_WIDTH, std::max(1.0, std::round(SNAPSHOT_WIDTH * fb.m_size.y / fb.m_size.x))};
+
+    g_pHyprRenderer->makeEGLCurrent();
+
+    if (!downscaleFB.isAllocated() || downscaleFB.m_size != SIZE)
+        downscaleFB.alloc(SIZE.x, SIZE.y, DRM_FORMAT_ABGR8888);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fb.getFBID());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, downscaleFB.getFBID());
+    glBlitFramebuffer(0, 0, fb.m_size.x, fb.m_size.y, 0, 0, SIZE.x, SIZE.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    // the copy into the pbo is queued like any other command, downscaleFB can be reused right after
+    SPendingReadback request{pWindow, SIZE};
+    glGenBuffers(1, &request.pbo);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, request.pbo);
+    glBufferData(GL_PIXEL_PACK_BUFFER, SIZE.x * SIZE.y * 4, nullptr, GL_STREAM_READ);
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, downscaleFB.getFBID());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glReadPixels(0, 0, SIZE.x, SIZE.y, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    request.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    glFlush();
+
+    pending.emplace_back(request);
+
+    if (pollTimer)
+        wl_event_source_timer_update(pollTimer, READBACK_POLL_MS);
+}
+
+void CSnapshotStore::onPollTimer() {
+    g_pHyprRenderer->makeEGLCurrent();
+
+    // fences signal in submission order, so the first unfinished one ends the scan
+    size_t done = 0;
+    for (auto& p : pending) {
+        if (glClientWaitSync(p.fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+            break;
+
+        if (p.pWindow) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, p.pbo);
+            const auto DATA = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, p.size.x * p.size.y * 4, GL_MAP_READ_BIT);
+            if (DATA) {
+                finish(p, DATA);
+                glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            }
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        }
+
+        destroy(p);
+        done++;
+    }
+
+    pending.erase(pending.begin(), pending.begin() + done);
+
+    if (!pending.empty()) {
+        if (pollTimer)
+            wl_event_source_timer_update(pollTimer, READBACK_POLL_MS);
+        return;
+    }
+
+    // burst is over, snapshots live in RAM and don't need the gpu side
+    downscaleFB.release();
+}
+
+void CSnapshotStore::finish(const SPendingReadback& request, const uint8_t* rgba) {
+    std::vector<uint16_t> pixels(request.size.x * request.size.y);
+    for (size_t i = 0; i < pixels.size(); ++i) {
+        const auto PX = &rgba[i * 4];
+        pixels[i]     = ((PX[0] >> 3) << 11) | ((PX[1] >> 2) << 5) | (PX[2] >> 3);
+    }
+
+    const auto PWINDOW = request.pWindow.lock();
+
+    auto       PSNAP = getSnapshot(PWINDOW);
+    if (!PSNAP)
+        PSNAP = &snapshots.emplace_back(SSnapshot{PWINDOW, {}, {}, {}});
+
+    totalBytes -= PSNAP->data.size() * sizeof(uint16_t);
+    encodeRLE(pixels, PSNAP->data);
+    totalBytes += PSNAP->data.size() * sizeof(uint16_t);
+
+    PSNAP->size     = request.size;
+    PSNAP->lastUsed = std::chrono::steady_clock::now();
+
+    enforceCap();
+}
+
+void CSnapshotStore::destroy(SPendingReadback& request) {
+    if (request.fence)
+        glDeleteSync(request.fence);
+    if (request.pbo)
+        glDeleteBuffers(1, &request.pbo);
+
+    request.fence = nullptr;
+    request.pbo   = 0;
+}
+
+SP<CTexture> CSnapshotStore::upload(PHLWINDOW pWindow) {
+    const auto PSNAP = getSnapshot(pWindow);
+
+    if (!PSNAP || PSNAP->data.empty())
+        return nullptr;
+
+    PSNAP->lastUsed = std::chrono::steady_clock::now();
+
+    decodeRLE(PSNAP->data, readback);
+
+    if (readback.size() != (size_t)(PSNAP->size.x * PSNAP->size.y * 4))
+        return nullptr;
+
+    return makeShared<CTexture>(DRM_FORMAT_ABGR8888, readback.data(), PSNAP->size.x * 4, PSNAP->size);
+}
+
+void CSnapshotStore::onWindowClosed(PHLWINDOW pWindow) {
+    g_pHyprRenderer->makeEGLCurrent();
+    std::erase_if(pending, [this, pWindow](auto& p) {
+        if (p.pWindow && p.pWindow != pWindow)
+            return false;
+
+        destroy(p);
+        return true;
+    });
+
+    std::erase_if(snapshots, [this, pWindow](const auto& s) {
+        if (s.pWindow && s.pWindow != pWindow)
+            return false;
+
+        totalBytes -= s.data.size() * sizeof(uint16_t);
+        return true;
+    });
+}
+
+void CSnapshotStore::enforceCap() {
+    static auto* const* PCAP = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:snapshot_cap_mb")->getDataStaticPtr();
+
+    const size_t        CAP  = std::max(**PCAP, (Hyprlang::INT)0) * 1024 * 1024;
+
+    while (totalBytes > CAP && !snapshots.empty()) {
+        auto OLDEST = std::ranges::min_element(snapshots, {}, &SSnapshot::lastUsed);
+        totalBytes -= OLDEST->data.size() * sizeof(uint16_t);
+        snapshots.erase(OLDEST);
+    }
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#define WLR_USE_UNSTABLE
+
+#include "globals.hpp"
+#include "CountedFramebuffer.hpp"
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include <hyprland/src/render/Texture.hpp>
+#include <GLES3/gl32.h>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+struct wl_event_source;
+
+// Last-known look of every window, kept in system RAM so the overview can show
+// windows it can't capture right now (hidden, other monitors) without holding a
+// texture for each of them. Snapshots are downscaled, stored as run-length encoded
+// RGB565 and evicted oldest-first past plugin:winview:snapshot_cap_mb.
+// Readback goes through a pixel buffer and is picked up once its fence signals, so
+// capturing never stalls the render thread on the GPU.
+class CSnapshotStore {
+  public:
+    CSnapshotStore();
+    ~CSnapshotStore();
+
+    // queues a readback of fb, the window must be what's in it.
+    // has() turns true only once the copy has arrived.
+    void         capture(PHLWINDOW pWindow, CCountedFramebuffer& fb);
+    bool         has(PHLWINDOW pWindow);
+    // decodes into a fresh texture, nullptr if there is no snapshot
+    SP<CTexture> upload(PHLWINDOW pWindow);
+    void         onWindowClosed(PHLWINDOW pWindow);
+
+    size_t       bytes() const;
+
+    void         onPollTimer();
+
+  private:
+    struct SSnapshot {
+        PHLWINDOWREF                          pWindow;
+        Vector2D                              size;
+        std::vector<uint16_t>                 data;
+        std::chrono::steady_clock::time_point lastUsed;
+    };
+
+    struct SPendingReadback {
+        PHLWINDOWREF pWindow;
+        Vector2D     size;
+        GLuint       pbo   = 0;
+        GLsync       fence = nullptr;
+    };
+
+    SSnapshot*                    getSnapshot(PHLWINDOW pWindow);
+    void                          finish(const SPendingReadback& request, const uint8_t* rgba);
+    void                          destroy(SPendingReadback& request);
+    void                          enforceCap();
+
+    std::vector<SSnapshot>        snapshots;
+    std::vector<SPendingReadback> pending;
+    CCountedFramebuffer           downscaleFB;
+    std::vector<uint8_t>          readback;
+    size_t                        totalBytes = 0;
+    wl_event_source*              pollTimer  = nullptr;
+};
+
+inline std::unique_ptr<CSnapshotStore> g_pSnapshotStore;
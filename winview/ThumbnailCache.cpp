@@ -0,0 +1,286 @@
+#include "ThumbnailCache.hpp"
+#define private public
+#include <hyprland/src/render/Renderer.hpp>
+#include <hyprland/src/render/OpenGL.hpp>
+#include <hyprland/src/Compositor.hpp>
+#include <hyprland/src/desktop/Window.hpp>
+#include <hyprland/src/helpers/time/Time.hpp>
+#include <hyprland/src/debug/Log.hpp>
+#include <hyprland/src/managers/SessionLockManager.hpp>
+#undef private
+#include "overview.hpp"
+#include "SnapshotStore.hpp"
+#include <optional>
+
+static int onIdleTimer(void* data) {
+    ((CThumbnailCache*)data)->onIdleTick();
+    return 0;
+}
+
+// whether the driver can render to 565, found out on the first rgb565 allocation
+static std::optional<bool> rgb565Renderable;
+
+CBox windowDamageBox(PHLWINDOW pWindow, PHLMONITOR pMonitor) {
+    return pWindow->getFullWindowBoundingBox().translate(-pMonitor->m_position).scale(pMonitor->m_scale);
+}
+
+void allocThumbnailFB(CCountedFramebuffer& fb, const Vector2D& size, PHLMONITOR pMonitor) {
+    static auto const* PFORMAT = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:thumbnail_format")->getDataStaticPtr();
+
+    if (std::string{*PFORMAT} != "rgb565" || rgb565Renderable == false) {
+        fb.alloc(size.x, size.y, pMonitor->m_drmFormat);
+        return;
+    }
+
+    // CFramebuffer only knows 4 byte storage, swap the texture's storage for 565 under it.
+    // Tiles lose their alpha channel, see thumbnailClearColor.
+    fb.alloc(size.x, size.y, DRM_FORMAT_ARGB8888);
+
+    glBindTexture(GL_TEXTURE_2D, fb.getTexture()->m_texID);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB565, size.x, size.y, 0, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, nullptr);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    if (!rgb565Renderable.has_value()) {
+        glBindFramebuffer(GL_FRAMEBUFFER, fb.getFBID());
+        const auto STATUS = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+        rgb565Renderable = STATUS == GL_FRAMEBUFFER_COMPLETE;
+
+        if (!*rgb565Renderable) {
+            Debug::log(ERR, "[winview] rgb565 thumbnails are not renderable here (status {}), using the monitor format instead", STATUS);
+            fb.release();
+            fb.alloc(size.x, size.y, pMonitor->m_drmFormat);
+            return;
+        }
+    }
+
+    fb.setBytesPerPixel(2);
+}
+
+CHyprColor thumbnailClearColor(const CHyprColor& color) {
+    static auto const*  PFORMAT = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:thumbnail_format")->getDataStaticPtr();
+    static auto* const* PCOL    = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:bg_col")->getDataStaticPtr();
+
+    if (std::string{*PFORMAT} == "rgb565" && rgb565Renderable != false)
+        return CHyprColor(**PCOL).stripA();
+
+    return color;
+}
+
+CThumbnailCache::CThumbnailCache(bool keepThumbnails_) : keepThumbnails(keepThumbnails_) {
+    idleTimer = wl_event_loop_add_timer(g_pCompositor->m_wlEventLoop, onIdleTimer, this);
+    armTimer(1);
+}
+
+CThumbnailCache::~CThumbnailCache() {
+    if (idleTimer)
+        wl_event_source_remove(idleTimer);
+
+    g_pHyprRenderer->makeEGLCurrent();
+    thumbnails.clear();
+    scratchFB.release();
+}
+
+bool CThumbnailCache::resident() const {
+    return keepThumbnails;
+}
+
+void CThumbnailCache::armTimer(int ms) {
+    if (!idleTimer)
+        return;
+
+    wl_event_source_timer_update(idleTimer, std::max(ms, 1));
+    timerArmed = true;
+}
+
+CThumbnailCache::SThumbnail* CThumbnailCache::getThumbnail(PHLWINDOW pWindow) {
+    for (auto& t : thumbnails) {
+        if (t.pWindow == pWindow)
+            return &t;
+    }
+
+    return nullptr;
+}
+
+SP<CCountedFramebuffer> CThumbnailCache::getFresh(PHLWINDOW pWindow) {
+    const auto PTHUMB = getThumbnail(pWindow);
+
+    if (!PTHUMB || PTHUMB->stale || !PTHUMB->fb || !PTHUMB->fb->isAllocated())
+        return nullptr;
+
+    return PTHUMB->fb;
+}
+
+void CThumbnailCache::store(PHLWINDOW pWindow, CCountedFramebuffer& fb) {
+    const auto PMONITOR = pWindow->m_monitor.lock();
+    if (!PMONITOR)
+        return;
+
+    auto PTHUMB = getThumbnail(pWindow);
+
+    if (!PTHUMB)
+        PTHUMB = &thumbnails.emplace_back(SThumbnail{pWindow, nullptr, true});
+
+    // snapshot-only: the overview snapshots its own tiles when it closes
+    if (keepThumbnails && PTHUMB->fb.get() != &fb)
+        copyDown(fb, *PTHUMB, PMONITOR);
+
+    PTHUMB->stale = false;
+}
+
+void CThumbnailCache::onDamage(PHLMONITOR pMonitor, const CBox& box) {
+    lastDamage = std::chrono::steady_clock::now();
+
+    for (auto& t : thumbnails) {
+        if (t.stale)
+            continue;
+
+        const auto PWINDOW = t.pWindow.lock();
+        if (!PWINDOW || PWINDOW->m_monitor != pMonitor)
+            continue;
+
+        if (!box.intersection(windowDamageBox(PWINDOW, pMonitor)).empty())
+            t.stale = true;
+    }
+
+    if (!timerArmed) {
+        static auto* const* PIDLE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:resident_idle_ms")->getDataStaticPtr();
+        armTimer(**PIDLE);
+    }
+}
+
+void CThumbnailCache::onWindowClosed(PHLWINDOW pWindow) {
+    g_pHyprRenderer->makeEGLCurrent();
+    std::erase_if(thumbnails, [pWindow](const auto& t) { return !t.pWindow || t.pWindow == pWindow; });
+}
+
+bool CThumbnailCache::canRenderOn(PHLMONITOR pMonitor) {
+    return pMonitor && pMonitor->m_enabled && pMonitor->m_dpmsStatus;
+}
+
+void CThumbnailCache::onIdleTick() {
+    static auto* const* PIDLE   = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:resident_idle_ms")->getDataStaticPtr();
+    static auto* const* PBUDGET = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:resident_budget_us")->getDataStaticPtr();
+
+    timerArmed = false;
+
+    // the overview keeps its own tiles up to date while it's open.
+    // VT switched away or locked: nothing to render to, and nothing changes that we could show.
+    if (g_pOverview || !g_pCompositor->m_sessionActive || g_pSessionLockManager->isSessionLocked()) {
+        armTimer(**PIDLE);
+        return;
+    }
+
+    const auto NOW         = std::chrono::steady_clock::now();
+    const auto SINCEDAMAGE = std::chrono::duration_cast<std::chrono::milliseconds>(NOW - lastDamage).count();
+
+    // something is still drawing, wait until the screen settles
+    if (SINCEDAMAGE < **PIDLE) {
+        armTimer(**PIDLE - SINCEDAMAGE);
+        return;
+    }
+
+    for (auto const& w : g_pCompositor->m_windows) {
+        if (!w->m_isMapped || getThumbnail(w))
+            continue;
+
+        thumbnails.emplace_back(SThumbnail{w, nullptr, true});
+    }
+
+    std::erase_if(thumbnails, [](const auto& t) { return !t.pWindow || !t.pWindow->m_isMapped; });
+
+    bool moreStale = false;
+
+    for (auto& t : thumbnails) {
+        // dpms-off outputs get picked up again by the damage they report once they wake
+        if (!t.stale || t.pWindow->isHidden() || !canRenderOn(t.pWindow->m_monitor.lock()))
+            continue;
+
+        if (std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - NOW).count() > **PBUDGET) {
+            moreStale = true;
+            break;
+        }
+
+        if (!refresh(t)) {
+            moreStale = true;
+            break;
+        }
+    }
+
+    if (moreStale) {
+        armTimer(**PIDLE);
+        return;
+    }
+
+    // burst is over, don't hold a full-size buffer while nothing needs it
+    scratchFB.release();
+}
+
+bool CThumbnailCache::refresh(SThumbnail& thumb) {
+    const auto PWINDOW  = thumb.pWindow.lock();
+    const auto PMONITOR = PWINDOW->m_monitor.lock();
+
+    g_pHyprRenderer->makeEGLCurrent();
+
+    // released after every burst, check that too and not just the size
+    if (!scratchFB.isAllocated() || scratchFB.m_size != PMONITOR->m_pixelSize) {
+        scratchFB.release();
+        scratchFB.alloc(PMONITOR->m_pixelSize.x, PMONITOR->m_pixelSize.y, PMONITOR->m_drmFormat);
+    }
+
+    g_pHyprRenderer->m_bBlockSurfaceFeedback = true;
+
+    CRegion fakeDamage{0, 0, INT16_MAX, INT16_MAX};
+    if (!g_pHyprRenderer->beginRender(PMONITOR, fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, &scratchFB)) {
+        g_pHyprRenderer->m_bBlockSurfaceFeedback = false;
+        Debug::log(LOG, "[winview] background refresh couldn't begin a render, retrying later");
+        return false;
+    }
+
+    g_pHyprOpenGL->clear(thumbnailClearColor(CHyprColor{0, 0, 0, 1.0}));
+
+    g_pHyprRenderer->renderWindow(PWINDOW, PMONITOR, Time::steadyNow(), true, RENDER_PASS_ALL, false, true);
+
+    g_pHyprOpenGL->m_renderData.blockScreenShader = true;
+    g_pHyprRenderer->endRender();
+
+    g_pHyprRenderer->m_bBlockSurfaceFeedback = false;
+
+    thumb.stale = false;
+
+    if (!keepThumbnails) {
+        if (g_pSnapshotStore)
+            g_pSnapshotStore->capture(PWINDOW, scratchFB);
+        return true;
+    }
+
+    copyDown(scratchFB, thumb, PMONITOR);
+
+    if (g_pSnapshotStore)
+        g_pSnapshotStore->capture(PWINDOW, *thumb.fb);
+
+    return true;
+}
+
+void CThumbnailCache::copyDown(CCountedFramebuffer& source, SThumbnail& thumb, PHLMONITOR pMonitor) {
+    static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
+
+    // a tile is never bigger than a column, so that's all the resolution we need
+    const Vector2D      THUMBSIZE = (pMonitor->m_pixelSize / std::max(**PCOLUMNS, (Hyprlang::INT)1)).round();
+
+    g_pHyprRenderer->makeEGLCurrent();
+
+    if (!thumb.fb)
+        thumb.fb = makeShared<CCountedFramebuffer>();
+
+    if (thumb.fb->m_size != THUMBSIZE) {
+        thumb.fb->release();
+        allocThumbnailFB(*thumb.fb, THUMBSIZE, pMonitor);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, source.getFBID());
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, thumb.fb->getFBID());
+    glBlitFramebuffer(0, 0, source.m_size.x, source.m_size.y, 0, 0, THUMBSIZE.x, THUMBSIZE.y, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
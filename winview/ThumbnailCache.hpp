@@ -0,0 +1,68 @@
+#pragma once
+
+#define WLR_USE_UNSTABLE
+
+#include "globals.hpp"
+#include <hyprland/src/desktop/DesktopTypes.hpp>
+#include "CountedFramebuffer.hpp"
+#include <chrono>
+#include <vector>
+
+struct wl_event_source;
+
+// Resident mode: keeps window thumbnails alive between overview sessions and
+// re-captures the stale ones at low resolution while the compositor is idle,
+// so opening the overview is just a texture draw.
+// Without resident but with show_all_windows it runs the same idle refresh only to
+// feed the snapshot store, and keeps nothing on the gpu between bursts.
+class CThumbnailCache {
+  public:
+    CThumbnailCache(bool keepThumbnails_ = true);
+    ~CThumbnailCache();
+
+    // false in snapshot-only mode
+    bool                    resident() const;
+
+    // nullptr if the window has no thumbnail or it was damaged since.
+    // The fb stays owned by the cache, don't render into it.
+    SP<CCountedFramebuffer> getFresh(PHLWINDOW pWindow);
+    // keeps a column-sized copy of an up to date capture of the window
+    void                    store(PHLWINDOW pWindow, CCountedFramebuffer& fb);
+
+    void                    onDamage(PHLMONITOR pMonitor, const CBox& box);
+    void                    onWindowClosed(PHLWINDOW pWindow);
+    void                    onIdleTick();
+
+  private:
+    struct SThumbnail {
+        PHLWINDOWREF            pWindow;
+        SP<CCountedFramebuffer> fb;
+        bool                    stale = true;
+    };
+
+    SThumbnail*                           getThumbnail(PHLWINDOW pWindow);
+    bool                                  refresh(SThumbnail& thumb);
+    void                                  copyDown(CCountedFramebuffer& source, SThumbnail& thumb, PHLMONITOR pMonitor);
+    bool                                  canRenderOn(PHLMONITOR pMonitor);
+    void                                  armTimer(int ms);
+
+    std::vector<SThumbnail>               thumbnails;
+    CCountedFramebuffer                   scratchFB;
+    bool                                  keepThumbnails = true;
+
+    wl_event_source*                      idleTimer  = nullptr;
+    bool                                  timerArmed = false;
+    std::chrono::steady_clock::time_point lastDamage = std::chrono::steady_clock::now();
+};
+
+inline std::unique_ptr<CThumbnailCache> g_pThumbnailCache;
+
+// allocates a thumbnail fb in plugin:winview:thumbnail_format instead of the
+// monitor's (possibly 10-bit) format
+void       allocThumbnailFB(CCountedFramebuffer& fb, const Vector2D& size, PHLMONITOR pMonitor);
+// what to clear a thumbnail to before drawing the window. Formats without alpha
+// get bg_col baked in so see-through parts don't turn black.
+CHyprColor thumbnailClearColor(const CHyprColor& color);
+
+// window bounding box in the monitor-local pixel space damage is reported in
+CBox windowDamageBox(PHLWINDOW pWindow, PHLMONITOR pMonitor);
@@ -0,0 +1,140 @@
+#include "Trace.hpp"
+#include <hyprland/src/debug/Log.hpp>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <unistd.h>
+
+uint64_t CTracer::nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+CTracer::~CTracer() {
+    if (writer.joinable())
+        writer.join();
+}
+
+uint64_t CTracer::beginSession() {
+    static auto const* PFILE = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:trace_file")->getDataStaticPtr();
+
+    if (active())
+        flush();
+
+    path = *PFILE;
+    if (path.empty())
+        return 0;
+
+    for (auto& e : ring) {
+        e.seq.store(0, std::memory_order_relaxed);
+    }
+
+    head.store(0, std::memory_order_relaxed);
+    sessionActive.store(true, std::memory_order_release);
+
+    return ++sessionToken;
+}
+
+void CTracer::endSession(uint64_t token) {
+    if (token == 0 || token != sessionToken || !active())
+        return;
+
+    flush();
+}
+
+void CTracer::record(const char* name, uint64_t startUs, uint64_t durUs) {
+    static thread_local const uint32_t TID = gettid();
+
+    const auto                         IDX = head.fetch_add(1, std::memory_order_relaxed);
+    auto&                              e   = ring[IDX % RING_SIZE];
+
+    // seqlock write side: mark the slot busy before any field changes
+    e.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    e.name.store(name, std::memory_order_relaxed);
+    e.startUs.store(startUs, std::memory_order_relaxed);
+    e.durUs.store(durUs, std::memory_order_relaxed);
+    e.tid.store(TID, std::memory_order_relaxed);
+    e.seq.store(IDX + 1, std::memory_order_release);
+}
+
+void CTracer::flush() {
+    if (!sessionActive.exchange(false, std::memory_order_acq_rel))
+        return;
+
+    // one file per session: /tmp/winview.json -> /tmp/winview-3.json
+    auto       filePath = path;
+    const auto SLASH    = filePath.find_last_of('/');
+    const auto DOT      = filePath.find_last_of('.');
+    const auto SUFFIX   = std::format("-{}", sessionID++);
+    if (DOT != std::string::npos && (SLASH == std::string::npos || DOT > SLASH))
+        filePath.insert(DOT, SUFFIX);
+    else
+        filePath += SUFFIX;
+
+    const auto           END   = head.load(std::memory_order_acquire);
+    const auto           BEGIN = END > RING_SIZE ? END - RING_SIZE : 0;
+
+    std::vector<SRecord> records;
+    records.reserve(END - BEGIN);
+
+    for (auto i = BEGIN; i < END; ++i) {
+        const auto& e = ring[i % RING_SIZE];
+
+        // slot is being written or was lapped
+        if (e.seq.load(std::memory_order_acquire) != i + 1)
+            continue;
+
+        SRecord record{e.name.load(std::memory_order_relaxed), e.startUs.load(std::memory_order_relaxed), e.durUs.load(std::memory_order_relaxed),
+                       e.tid.load(std::memory_order_relaxed)};
+
+        // keeps the field reads above from moving past the re-check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (e.seq.load(std::memory_order_relaxed) != i + 1)
+            continue;
+
+        records.emplace_back(record);
+    }
+
+    // the previous file is long done by now, this practically never blocks
+    if (writer.joinable())
+        writer.join();
+
+    writer = std::thread(write, std::move(filePath), std::move(records), END > RING_SIZE);
+}
+
+void CTracer::write(std::string filePath, std::vector<SRecord> records, bool overflowed) {
+    std::ofstream ofs(filePath, std::ios::trunc);
+    if (!ofs.good()) {
+        Debug::log(ERR, "[winview] couldn't open trace file {}", filePath);
+        return;
+    }
+
+    const auto PID   = getpid();
+    bool       first = true;
+
+    ofs << "{\"traceEvents\":[";
+    for (auto const& r : records) {
+        ofs << std::format("{}{{\"name\":\"{}\",\"cat\":\"winview\",\"ph\":\"X\",\"ts\":{},\"dur\":{},\"pid\":{},\"tid\":{}}}", first ? "" : ",\n", r.name, r.startUs, r.durUs, PID,
+                           r.tid);
+        first = false;
+    }
+    ofs << "],\"displayTimeUnit\":\"ms\"}\n";
+
+    if (overflowed)
+        Debug::log(LOG, "[winview] trace ring overflowed, {} only has the newest spans", filePath);
+}
+
+CTraceSpan::CTraceSpan(const char* name_) {
+    if (!g_pTracer || !g_pTracer->active())
+        return;
+
+    name    = name_;
+    startUs = CTracer::nowUs();
+}
+
+CTraceSpan::~CTraceSpan() {
+    if (!name || !g_pTracer || !g_pTracer->active())
+        return;
+
+    g_pTracer->record(name, startUs, CTracer::nowUs() - startUs);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "globals.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Opt-in timeline of overview sessions (plugin:winview:trace_file).
+// Spans land in a fixed ring without locks or allocations. When the session ends the
+// ring is copied out and written as Chrome trace-event JSON on a worker thread,
+// load it in ui.perfetto.dev.
+class CTracer {
+  public:
+    ~CTracer();
+
+    // starting a session ends the previous one (swipe reopen builds the new overview
+    // before the old one is gone). Returns a token for endSession, 0 if disabled.
+    uint64_t        beginSession();
+    // no-op unless the token belongs to the running session
+    void            endSession(uint64_t token);
+
+    void            record(const char* name, uint64_t startUs, uint64_t durUs);
+
+    bool            active() const {
+        return sessionActive.load(std::memory_order_relaxed);
+    }
+
+    static uint64_t nowUs();
+
+  private:
+    // a seqlock per slot, the fields are atomics so a racing flush() reads a torn
+    // record at worst, which the seq re-check then drops
+    struct SEvent {
+        std::atomic<uint64_t>    seq     = 0; // 1 + the write index that last filled this slot
+        std::atomic<const char*> name    = nullptr;
+        std::atomic<uint64_t>    startUs = 0;
+        std::atomic<uint64_t>    durUs   = 0;
+        std::atomic<uint32_t>    tid     = 0;
+    };
+
+    struct SRecord {
+        const char* name    = nullptr;
+        uint64_t    startUs = 0;
+        uint64_t    durUs   = 0;
+        uint32_t    tid     = 0;
+    };
+
+    void                           flush();
+    static void                    write(std::string filePath, std::vector<SRecord> records, bool overflowed);
+
+    static constexpr size_t        RING_SIZE = 16384;
+
+    std::array<SEvent, RING_SIZE>  ring;
+    std::atomic<uint64_t>          head          = 0;
+    std::atomic<bool>              sessionActive = false;
+
+    std::string                    path;
+    uint64_t                       sessionToken = 0;
+    int                            sessionID    = 0;
+
+    std::thread                    writer;
+};
+
+inline std::unique_ptr<CTracer> g_pTracer;
+
+// records the lifetime of the scope as a span, names must be string literals
+class CTraceSpan {
+  public:
+    CTraceSpan(const char* name_);
+    ~CTraceSpan();
+
+  private:
+    const char* name    = nullptr;
+    uint64_t    startUs = 0;
+};
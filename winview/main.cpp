@@ -10,6 +10,9 @@
 
 #include "globals.hpp"
 #include "overview.hpp"
+#include "ThumbnailCache.hpp"
+#include "SnapshotStore.hpp"
+#include "Trace.hpp"
 
 // Methods
 inline CFunctionHook* g_pRenderWorkspaceHook = nullptr;
@@ -35,25 +38,37 @@ static void hkRenderWorkspace(void* thisptr, PHLMONITOR pMonitor, PHLWORKSPACE p
 }
 
 static void hkAddDamageA(void* thisptr, const CBox& box) {
+    CTraceSpan span("hkAddDamageA");
+
     const auto PMONITOR = (CMonitor*)thisptr;
 
+    if (g_pThumbnailCache && !(g_pOverview && g_pOverview->blockDamageReporting))
+        g_pThumbnailCache->onDamage(PMONITOR->m_self.lock(), box);
+
     if (!g_pOverview || g_pOverview->pMonitor != PMONITOR->m_self || g_pOverview->blockDamageReporting) {
         ((origAddDamageA)g_pAddDamageHookA->m_original)(thisptr, box);
         return;
     }
 
-    g_pOverview->onDamageReported();
+    g_pOverview->onDamageReported(box);
 }
 
 static void hkAddDamageB(void* thisptr, const pixman_region32_t* rg) {
+    CTraceSpan span("hkAddDamageB");
+
     const auto PMONITOR = (CMonitor*)thisptr;
+    const auto EXTENTS  = pixman_region32_extents(rg);
+    const auto BOX      = CBox{EXTENTS->x1, EXTENTS->y1, EXTENTS->x2 - EXTENTS->x1, EXTENTS->y2 - EXTENTS->y1};
+
+    if (g_pThumbnailCache && !(g_pOverview && g_pOverview->blockDamageReporting))
+        g_pThumbnailCache->onDamage(PMONITOR->m_self.lock(), BOX);
 
     if (!g_pOverview || g_pOverview->pMonitor != PMONITOR->m_self || g_pOverview->blockDamageReporting) {
         ((origAddDamageB)g_pAddDamageHookB->m_original)(thisptr, rg);
         return;
     }
 
-    g_pOverview->onDamageReported();
+    g_pOverview->onDamageReported(BOX);
 }
 
 static float gestured       = 0;
@@ -61,6 +76,8 @@ bool         swipeActive    = false;
 char         swipeDirection = 0; // 0 = no direction, 'v' = vertical, 'h' = horizontal
 
 static void  swipeBegin(void* self, SCallbackInfo& info, std::any param) {
+    CTraceSpan span("swipeBegin");
+
     swipeActive    = false;
     swipeDirection = 0;
 }
@@ -71,6 +88,7 @@ static void swipeUpdate(void* self, SCallbackInfo& info, std::any param) {
     static auto* const* PPOSITIVE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_positive")->getDataStaticPtr();
     static auto* const* PDISTANCE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_distance")->getDataStaticPtr();
     auto                e         = std::any_cast<IPointer::SSwipeUpdateEvent>(param);
+    CTraceSpan          span("swipeUpdate");
 
     if (!swipeDirection) {
         if (std::abs(e.delta.x) > std::abs(e.delta.y))
@@ -117,6 +135,8 @@ static void swipeUpdate(void* self, SCallbackInfo& info, std::any param) {
 }
 
 static void swipeEnd(void* self, SCallbackInfo& info, std::any param) {
+    CTraceSpan span("swipeEnd");
+
     if (!g_pOverview)
         return;
 
@@ -162,6 +182,64 @@ static void onOverviewDispatcher(std::string arg) {
     renderingOverview = false;
 }
 
+// drives the gesture handlers like a touchpad would, for tests/stress.sh.
+// begin | update <dy> | end
+static void onDebugSwipeDispatcher(std::string arg) {
+    static auto* const* FINGERS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_fingers")->getDataStaticPtr();
+
+    SCallbackInfo       info;
+
+    if (arg == "begin")
+        swipeBegin(nullptr, info, {});
+    else if (arg == "end")
+        swipeEnd(nullptr, info, {});
+    else if (arg.starts_with("update ")) {
+        IPointer::SSwipeUpdateEvent e;
+        e.fingers = **FINGERS;
+        try {
+            e.delta = Vector2D{0, std::stod(arg.substr(7))};
+        } catch (...) { return; }
+        swipeUpdate(nullptr, info, e);
+    }
+}
+
+static void onConfigReloaded() {
+    static auto* const* PRESIDENT = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:resident")->getDataStaticPtr();
+    static auto* const* PSHOWALL  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:show_all_windows")->getDataStaticPtr();
+    static auto const*  PTRACE    = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:trace_file")->getDataStaticPtr();
+
+    // a session in flight still records into the tracer
+    if (!std::string{*PTRACE}.empty() && !g_pTracer)
+        g_pTracer = std::make_unique<CTracer>();
+    else if (std::string{*PTRACE}.empty() && g_pTracer && !g_pOverview)
+        g_pTracer.reset();
+
+    // open tiles may hold textures uploaded from the store, but not the store itself
+    if (**PSHOWALL && !g_pSnapshotStore)
+        g_pSnapshotStore = std::make_unique<CSnapshotStore>();
+    else if (!**PSHOWALL && g_pSnapshotStore)
+        g_pSnapshotStore.reset();
+
+    // snapshots are taken by the idle refresh while windows are still visible, so show_all_windows
+    // needs the cache too, just without keeping thumbnails around
+    if (!**PRESIDENT && !**PSHOWALL)
+        g_pThumbnailCache.reset();
+    else if (!g_pThumbnailCache || g_pThumbnailCache->resident() != (bool)**PRESIDENT)
+        g_pThumbnailCache = std::make_unique<CThumbnailCache>(**PRESIDENT);
+}
+
+static std::string onFBStats(eHyprCtlOutputFormat format, std::string request) {
+    const size_t SNAPSHOTBYTES = g_pSnapshotStore ? g_pSnapshotStore->bytes() : 0;
+    const bool   RESIDENT      = g_pThumbnailCache && g_pThumbnailCache->resident();
+
+    if (format == eHyprCtlOutputFormat::FORMAT_JSON)
+        return std::format("{{\"framebuffers\": {}, \"bytes\": {}, \"overview\": {}, \"resident\": {}, \"snapshotBytes\": {}}}", CCountedFramebuffer::liveCount(),
+                           CCountedFramebuffer::liveBytes(), (bool)g_pOverview, RESIDENT, SNAPSHOTBYTES);
+
+    return std::format("framebuffers: {}\nbytes: {}\noverview: {}\nresident: {}\nsnapshot bytes: {}\n", CCountedFramebuffer::liveCount(), CCountedFramebuffer::liveBytes(),
+                       (bool)g_pOverview, RESIDENT, SNAPSHOTBYTES);
+}
+
 static void failNotif(const std::string& reason) {
     HyprlandAPI::addNotification(PHANDLE, "[winview] Failure in initialization: " + reason, CHyprColor{1.0, 0.2, 0.2, 1.0}, 5000);
 }
@@ -212,14 +290,24 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle) {
     static auto P = HyprlandAPI::registerCallbackDynamic(PHANDLE, "preRender", [](void* self, SCallbackInfo& info, std::any param) {
         if (!g_pOverview)
             return;
-        g_pOverview->onPreRender();
+        g_pOverview->onPreRender(std::any_cast<PHLMONITOR>(param));
     });
 
     static auto P2 = HyprlandAPI::registerCallbackDynamic(PHANDLE, "swipeBegin", [](void* self, SCallbackInfo& info, std::any data) { swipeBegin(self, info, data); });
     static auto P3 = HyprlandAPI::registerCallbackDynamic(PHANDLE, "swipeEnd", [](void* self, SCallbackInfo& info, std::any data) { swipeEnd(self, info, data); });
     static auto P4 = HyprlandAPI::registerCallbackDynamic(PHANDLE, "swipeUpdate", [](void* self, SCallbackInfo& info, std::any data) { swipeUpdate(self, info, data); });
 
+    static auto P5 = HyprlandAPI::registerCallbackDynamic(PHANDLE, "configReloaded", [](void* self, SCallbackInfo& info, std::any data) { onConfigReloaded(); });
+    static auto P6 = HyprlandAPI::registerCallbackDynamic(PHANDLE, "closeWindow", [](void* self, SCallbackInfo& info, std::any data) {
+        if (g_pThumbnailCache)
+            g_pThumbnailCache->onWindowClosed(std::any_cast<PHLWINDOW>(data));
+        if (g_pSnapshotStore)
+            g_pSnapshotStore->onWindowClosed(std::any_cast<PHLWINDOW>(data));
+    });
+
     HyprlandAPI::addDispatcher(PHANDLE, "winview:overview", onOverviewDispatcher);
+    HyprlandAPI::addDispatcher(PHANDLE, "winview:debugswipe", onDebugSwipeDispatcher);
+    HyprlandAPI::registerHyprCtlCommand(PHANDLE, SHyprCtlCommand{"winview:fbstats", true, onFBStats});
 
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:columns", Hyprlang::INT{3});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:gap_size", Hyprlang::INT{5});
@@ -227,17 +315,34 @@ APICALL EXPORT PLUGIN_DESCRIPTION_INFO PLUGIN_INIT(HANDLE handle) {
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:workspace_method", Hyprlang::STRING{"first"}); // not used for windows but kept for compatibility
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:include_special", Hyprlang::INT{0});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:skip_empty", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:blur_bg", Hyprlang::INT{0});
 
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:enable_gesture", Hyprlang::INT{1});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:gesture_distance", Hyprlang::INT{200});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:gesture_positive", Hyprlang::INT{1});
     HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:gesture_fingers", Hyprlang::INT{4});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:gesture_prediction", Hyprlang::INT{1});
+
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:thumbnail_format", Hyprlang::STRING{"monitor"});
+
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:show_all_windows", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:snapshot_cap_mb", Hyprlang::INT{32});
+
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:trace_file", Hyprlang::STRING{""});
+
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:resident", Hyprlang::INT{0});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:resident_idle_ms", Hyprlang::INT{500});
+    HyprlandAPI::addConfigValue(PHANDLE, "plugin:winview:resident_budget_us", Hyprlang::INT{2000});
 
     HyprlandAPI::reloadConfig();
+    onConfigReloaded();
 
     return {"winview", "A plugin for window overview", "Vaxry", "1.0"};
 }
 
 APICALL EXPORT void PLUGIN_EXIT() {
     g_pHyprRenderer->m_renderPass.removeAllOfType("COverviewPassElement");
+    g_pThumbnailCache.reset();
+    g_pSnapshotStore.reset();
+    g_pTracer.reset(); // joins a trace write still in flight before our code is unmapped
 }
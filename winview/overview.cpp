@@ -10,23 +10,64 @@
 #include <hyprland/src/helpers/time/Time.hpp>
 #undef private
 #include "OverviewPassElement.hpp"
+#include "ThumbnailCache.hpp"
+#include "SnapshotStore.hpp"
+#include "Trace.hpp"
+
+// blurred backdrop rebuilds wait for damage to stop for this long, but never longer than the max
+constexpr int BACKDROP_SETTLE_MS    = 250;
+constexpr int BACKDROP_MAX_DELAY_MS = 1000;
 
 static void damageMonitor(WP<Hyprutils::Animation::CBaseAnimatedVariable> thisptr) {
+    CTraceSpan span("anim:damageMonitor");
     g_pOverview->damage();
 }
 
+static int backdropTimerCallback(void* data) {
+    ((COverview*)data)->onBackdropTimer();
+    return 0;
+}
+
 static void removeOverview(WP<Hyprutils::Animation::CBaseAnimatedVariable> thisptr) {
+    CTraceSpan span("anim:removeOverview");
     g_pOverview.reset();
+
+    // checked here and not in the destructor: a swipe reopen builds the next overview before the old one dies.
+    // Without resident mode or snapshots nothing may outlive the session.
+    if (!g_pOverview && !g_pThumbnailCache && !g_pSnapshotStore && CCountedFramebuffer::liveCount())
+        Debug::log(WARN, "[winview] {} framebuffers ({} bytes) still alive after closing the overview", CCountedFramebuffer::liveCount(), CCountedFramebuffer::liveBytes());
 }
 
 COverview::~COverview() {
     g_pHyprRenderer->makeEGLCurrent();
+
+    // remember what everything looked like for when it can't be captured anymore.
+    // Tiles we only borrowed from the resident cache were snapshotted when it refreshed them.
+    if (g_pSnapshotStore) {
+        for (auto& image : images) {
+            if (image.rendered && image.fb && image.pWindow && validMapped(image.pWindow))
+                g_pSnapshotStore->capture(image.pWindow, *image.fb);
+        }
+    }
+
     images.clear(); // otherwise we get a vram leak
+    if (backdropTimer)
+        wl_event_source_remove(backdropTimer);
+    backdropFB.release();
+    backdropWorkspaceFB.release();
     g_pInputManager->unsetCursorImage();
     g_pHyprOpenGL->markBlurDirtyForMonitor(pMonitor.lock());
+
+    if (g_pTracer)
+        g_pTracer->endSession(traceSession);
 }
 
 COverview::COverview(PHLWINDOW startedWindow, bool swipe_) : focusedWindow(startedWindow), swipe(swipe_), pWindow(startedWindow) {
+    if (g_pTracer)
+        traceSession = g_pTracer->beginSession();
+
+    CTraceSpan span("COverview::COverview");
+
     const auto PMONITOR = g_pCompositor->m_lastMonitor;
     pMonitor            = PMONITOR;
 
@@ -36,6 +77,7 @@ COverview::COverview(PHLWINDOW startedWindow, bool swipe_) : focusedWindow(start
     static auto* const* PSKIP           = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:skip_empty")->getDataStaticPtr();
     static auto* const* PINCLUDESPECIAL = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:include_special")->getDataStaticPtr();
     static auto const*  PMETHOD         = (Hyprlang::STRING const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:workspace_method")->getDataStaticPtr();
+    static auto* const* PBLUR           = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:blur_bg")->getDataStaticPtr();
 
     SIDE_LENGTH = **PCOLUMNS;
     GAP_WIDTH   = **PGAPS;
@@ -44,11 +86,12 @@ COverview::COverview(PHLWINDOW startedWindow, bool swipe_) : focusedWindow(start
     // Collect all windows from all workspaces on the current monitor
     std::vector<PHLWINDOW> allWindows;
     for (auto const& w : g_pCompositor->m_windows) {
-        if (!w->m_isMapped || w->isHidden())
+        if (!w->m_isMapped)
             continue;
             
-        // Filter by monitor - only show windows on the current monitor
-        if (w->m_monitor != pMonitor)
+        // Filter by monitor - only show windows on the current monitor,
+        // unless there's a snapshot of them to show instead
+        if ((w->isHidden() || w->m_monitor != pMonitor) && !(g_pSnapshotStore && g_pSnapshotStore->has(w)))
             continue;
             
         // Skip windows that don't want focus
@@ -102,29 +145,50 @@ COverview::COverview(PHLWINDOW startedWindow, bool swipe_) : focusedWindow(start
         if (!image.pWindow)
             continue;
 
-        image.fb.alloc(monbox.w, monbox.h, pMonitor.lock()->m_drmFormat);
+        // Calculate tile position in the grid
+        image.box = {image.position.x * tileRenderSize.x + image.position.x * GAP_WIDTH, 
+                     image.position.y * tileRenderSize.y + image.position.y * GAP_WIDTH, 
+                     tileRenderSize.x, tileRenderSize.y};
+
+        if (image.pWindow->isHidden() || image.pWindow->m_monitor != pMonitor) {
+            image.snapshot = g_pSnapshotStore->upload(image.pWindow);
+            continue;
+        }
+
+        // resident mode may already have an up to date capture. It's shared with the cache,
+        // redrawID swaps it for a buffer of our own before drawing into it.
+        if (g_pThumbnailCache && (image.fb = g_pThumbnailCache->getFresh(image.pWindow)))
+            continue;
+
+        image.fb = makeShared<CCountedFramebuffer>();
+        allocThumbnailFB(*image.fb, monbox.size(), pMonitor.lock());
 
         CRegion fakeDamage{0, 0, INT16_MAX, INT16_MAX};
-        g_pHyprRenderer->beginRender(pMonitor.lock(), fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, &image.fb);
+        g_pHyprRenderer->beginRender(pMonitor.lock(), fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, image.fb.get());
 
-        g_pHyprOpenGL->clear(CHyprColor(0, 0, 0, 0)); // Clear to transparent
+        g_pHyprOpenGL->clear(thumbnailClearColor(CHyprColor(0, 0, 0, 0))); // Clear to transparent
 
         // Render the window
         if (image.pWindow) {
             g_pHyprRenderer->renderWindow(image.pWindow, pMonitor.lock(), Time::steadyNow(), true, RENDER_PASS_ALL, false, true);
         }
 
-        // Calculate tile position in the grid
-        image.box = {image.position.x * tileRenderSize.x + image.position.x * GAP_WIDTH, 
-                     image.position.y * tileRenderSize.y + image.position.y * GAP_WIDTH, 
-                     tileRenderSize.x, tileRenderSize.y};
-
         g_pHyprOpenGL->m_renderData.blockScreenShader = true;
         g_pHyprRenderer->endRender();
+
+        image.rendered = true;
+
+        if (g_pThumbnailCache)
+            g_pThumbnailCache->store(image.pWindow, *image.fb);
     }
 
     g_pHyprRenderer->m_bBlockSurfaceFeedback = false;
 
+    if (**PBLUR) {
+        backdropTimer = wl_event_loop_add_timer(g_pCompositor->m_wlEventLoop, backdropTimerCallback, this);
+        renderBackdrop();
+    }
+
     // Find index of the currently focused window
     int currentid = 0;
     for (size_t i = 0; i < images.size(); ++i) {
@@ -149,7 +213,10 @@ COverview::COverview(PHLWINDOW startedWindow, bool swipe_) : focusedWindow(start
         size->setValueAndWarp(pMonitor.lock()->m_size);
         pos->setValueAndWarp(Vector2D{0, 0});
 
-        size->setCallbackOnEnd([this](auto) { redrawAll(true); });
+        size->setCallbackOnEnd([this](auto) {
+            CTraceSpan span("anim:openEnd");
+            redrawOutdated(true);
+        });
     }
 
     openedID = currentid;
@@ -216,11 +283,11 @@ void COverview::selectHoveredWindow() {
 }
 
 void COverview::redrawID(int id, bool forcelowres) {
+    CTraceSpan span("COverview::redrawID");
+
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
     static auto* const* PGAPS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gap_size")->getDataStaticPtr();
     
-    blockOverviewRendering = true;
-
     g_pHyprRenderer->makeEGLCurrent();
 
     id = std::clamp(id, 0, (int)images.size() - 1);
@@ -243,18 +310,22 @@ void COverview::redrawID(int id, bool forcelowres) {
 
     auto& image = images[id];
 
-    if (!image.pWindow)
+    // snapshot-only tiles can't be captured
+    if (!image.pWindow || !image.fb)
         return;
 
-    if (image.fb.m_size != monbox.size()) {
-        image.fb.release();
-        image.fb.alloc(monbox.w, monbox.h, pMonitor.lock()->m_drmFormat);
+    blockOverviewRendering = true;
+
+    // new buffer rather than a resize, the old one may be the resident cache's
+    if (image.fb->m_size != monbox.size()) {
+        image.fb = makeShared<CCountedFramebuffer>();
+        allocThumbnailFB(*image.fb, monbox.size(), pMonitor.lock());
     }
 
     CRegion fakeDamage{0, 0, INT16_MAX, INT16_MAX};
-    g_pHyprRenderer->beginRender(pMonitor.lock(), fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, &image.fb);
+    g_pHyprRenderer->beginRender(pMonitor.lock(), fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, image.fb.get());
 
-    g_pHyprOpenGL->clear(CHyprColor{0, 0, 0, 1.0});
+    g_pHyprOpenGL->clear(thumbnailClearColor(CHyprColor{0, 0, 0, 0})); // same as the first capture, keeps the backdrop showing through
 
     // Render the window
     g_pHyprRenderer->renderWindow(image.pWindow, pMonitor.lock(), Time::steadyNow(), true, RENDER_PASS_ALL, false, true);
@@ -262,11 +333,90 @@ void COverview::redrawID(int id, bool forcelowres) {
     g_pHyprOpenGL->m_renderData.blockScreenShader = true;
     g_pHyprRenderer->endRender();
 
+    image.stale    = false;
+    image.rendered = true;
+
+    if (g_pThumbnailCache)
+        g_pThumbnailCache->store(image.pWindow, *image.fb);
+
     blockOverviewRendering = false;
 }
 
-void COverview::redrawAll(bool forcelowres) {
+void COverview::renderBackdrop() {
+    CTraceSpan span("COverview::renderBackdrop");
+
+    const auto PMONITOR = pMonitor.lock();
+
+    if (!PMONITOR || !PMONITOR->m_activeWorkspace)
+        return;
+
+    blockOverviewRendering = true;
+
+    g_pHyprRenderer->makeEGLCurrent();
+
+    CBox monbox = {{0, 0}, PMONITOR->m_pixelSize};
+
+    if (backdropWorkspaceFB.m_size != monbox.size()) {
+        backdropWorkspaceFB.release();
+        backdropWorkspaceFB.alloc(monbox.w, monbox.h, PMONITOR->m_drmFormat);
+    }
+
+    if (backdropFB.m_size != monbox.size()) {
+        backdropFB.release();
+        backdropFB.alloc(monbox.w, monbox.h, PMONITOR->m_drmFormat);
+    }
+
+    g_pHyprRenderer->m_bBlockSurfaceFeedback = true;
+
+    CRegion fakeDamage{0, 0, INT16_MAX, INT16_MAX};
+    if (!g_pHyprRenderer->beginRender(PMONITOR, fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, &backdropWorkspaceFB)) {
+        g_pHyprRenderer->m_bBlockSurfaceFeedback = false;
+        blockOverviewRendering                   = false;
+        return;
+    }
+
+    g_pHyprOpenGL->clear(BG_COLOR.stripA());
+    g_pHyprRenderer->renderWorkspace(PMONITOR, PMONITOR->m_activeWorkspace, Time::steadyNow(), CBox{{0, 0}, PMONITOR->m_size});
+
+    g_pHyprOpenGL->m_renderData.blockScreenShader = true;
+    g_pHyprRenderer->endRender();
+
+    // the workspace render is queued on the pass, so blur in a second pass once it's actually drawn
+    g_pHyprRenderer->beginRender(PMONITOR, fakeDamage, RENDER_MODE_FULL_FAKE, nullptr, &backdropFB);
+
+    g_pHyprOpenGL->renderTextureInternalWithDamage(backdropWorkspaceFB.getTexture(), monbox, 1.0, fakeDamage);
+    const auto BLURREDFB = g_pHyprOpenGL->blurMainFramebufferWithDamage(1.0, &fakeDamage);
+    g_pHyprOpenGL->renderTextureInternalWithDamage(BLURREDFB->getTexture(), monbox, 1.0, fakeDamage);
+
+    g_pHyprOpenGL->m_renderData.blockScreenShader = true;
+    g_pHyprRenderer->endRender();
+
+    g_pHyprRenderer->m_bBlockSurfaceFeedback = false;
+
+    blockOverviewRendering = false;
+}
+
+void COverview::onBackdropTimer() {
+    if (!backdropDirty || closing)
+        return;
+
+    // animation frames keep reusing the old snapshot
+    if (size->isBeingAnimated()) {
+        wl_event_source_timer_update(backdropTimer, BACKDROP_SETTLE_MS);
+        return;
+    }
+
+    backdropDirty = false;
+    renderBackdrop();
+    damage();
+}
+
+void COverview::redrawOutdated(bool forcelowres) {
     for (size_t i = 0; i < images.size(); ++i) {
+        // still the resident cache's column-size capture, that's already tile sized
+        if (images[i].fb && !images[i].rendered && !images[i].stale)
+            continue;
+
         redrawID(i, forcelowres);
     }
 }
@@ -277,12 +427,33 @@ void COverview::damage() {
     blockDamageReporting = false;
 }
 
-void COverview::onDamageReported() {
+void COverview::onDamageReported(const CBox& box) {
+    CTraceSpan span("COverview::onDamageReported");
+
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
     static auto* const* PGAPS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gap_size")->getDataStaticPtr();
     
+    static auto* const* PBLUR = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:blur_bg")->getDataStaticPtr();
+
     damageDirty = true;
 
+    // debounce rebuilds, but don't let continuous damage (video, a clock) hold them off forever
+    if (**PBLUR && backdropTimer) {
+        const auto NOW = std::chrono::steady_clock::now();
+        if (!backdropDirty) {
+            backdropDirty      = true;
+            backdropDirtySince = NOW;
+        }
+
+        const auto SINCE = std::chrono::duration_cast<std::chrono::milliseconds>(NOW - backdropDirtySince).count();
+        wl_event_source_timer_update(backdropTimer, std::max<int>(1, std::min<int>(BACKDROP_SETTLE_MS, BACKDROP_MAX_DELAY_MS - SINCE)));
+    }
+
+    for (auto& image : images) {
+        if (image.pWindow && !box.intersection(windowDamageBox(image.pWindow, pMonitor.lock())).empty())
+            image.stale = true;
+    }
+
     Vector2D SIZE = size->value();
     int gridCols = **PCOLUMNS;
     int GAP_WIDTH = **PGAPS;
@@ -307,6 +478,8 @@ void COverview::onDamageReported() {
 }
 
 void COverview::close() {
+    CTraceSpan span("COverview::close");
+
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
     
     if (closing)
@@ -338,10 +511,36 @@ void COverview::close() {
 
     closing = true;
 
-    redrawAll();
+    // only the selected tile fills the screen at the end, everything else keeps its texture.
+    // Redraw it if it changed or was captured at a lower resolution.
+    if (ID >= 0 && ID < (int)images.size()) {
+        const auto& TILE = images[ID];
+        if (TILE.stale || !TILE.fb || TILE.fb->m_size != pMonitor->m_pixelSize)
+            redrawID(ID);
+    }
 }
 
-void COverview::onPreRender() {
+void COverview::onPreRender(PHLMONITOR pRenderMonitor) {
+    CTraceSpan span("COverview::onPreRender");
+
+    // preRender fires for every monitor, only our own frame shows the swipe
+    if (swipeState.pending && pRenderMonitor == pMonitor) {
+        static auto* const* PPREDICT  = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_prediction")->getDataStaticPtr();
+        static auto* const* PDISTANCE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_distance")->getDataStaticPtr();
+
+        swipeState.pending = false;
+
+        double delta = swipeState.delta;
+        if (**PPREDICT) {
+            // this frame shows up about one refresh from now, extrapolate the finger to then
+            const double FRAME = 1.0 / std::max(pMonitor->m_refreshRate, 1.F);
+            const double LEAD  = std::min(std::chrono::duration<double>(std::chrono::steady_clock::now() - swipeState.lastSample).count() + FRAME, 2 * FRAME);
+            delta              = std::clamp(delta + swipeState.velocity * LEAD, 0.01, (double)**PDISTANCE);
+        }
+
+        applySwipe(delta);
+    }
+
     if (damageDirty) {
         damageDirty = false;
         redrawID(closing ? (closeOnID == -1 ? openedID : closeOnID) : openedID);
@@ -370,6 +569,8 @@ void COverview::render() {
 }
 
 void COverview::fullRender() {
+    CTraceSpan span("COverview::fullRender");
+
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
     static auto* const* PGAPS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gap_size")->getDataStaticPtr();
     static auto* const* PCOL = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:bg_col")->getDataStaticPtr();
@@ -385,7 +586,11 @@ void COverview::fullRender() {
     int gridRows = (images.size() + gridCols - 1) / gridCols;
     Vector2D tileRenderSize = (SIZE - Vector2D{GAPSIZE, GAPSIZE} * (std::max(gridCols, gridRows) - 1)) / std::max(gridCols, gridRows);
 
-    g_pHyprOpenGL->clear(BG_COLOR.stripA());
+    if (backdropFB.isAllocated()) {
+        CRegion damage{0, 0, INT16_MAX, INT16_MAX};
+        g_pHyprOpenGL->renderTextureInternalWithDamage(backdropFB.getTexture(), CBox{{0, 0}, pMonitor->m_pixelSize}, 1.0, damage);
+    } else
+        g_pHyprOpenGL->clear(BG_COLOR.stripA());
 
     for (size_t i = 0; i < images.size(); ++i) {
         int x = i % gridCols;
@@ -395,7 +600,11 @@ void COverview::fullRender() {
         texbox.scale(pMonitor.lock()->m_scale).translate(pos->value());
         texbox.round();
         CRegion damage{0, 0, INT16_MAX, INT16_MAX};
-        g_pHyprOpenGL->renderTextureInternalWithDamage(images[i].fb.getTexture(), texbox, 1.0, damage);
+        const auto TEX = images[i].fb ? images[i].fb->getTexture() : images[i].snapshot;
+        if (!TEX)
+            continue;
+
+        g_pHyprOpenGL->renderTextureInternalWithDamage(TEX, texbox, 1.0, damage);
     }
 }
 
@@ -408,9 +617,36 @@ static Vector2D lerp(const Vector2D& from, const Vector2D& to, const float perc)
 }
 
 void COverview::onSwipeUpdate(double delta) {
+    CTraceSpan span("COverview::onSwipeUpdate");
+
     if (swipeWasCommenced)
         return;
 
+    const auto NOW = std::chrono::steady_clock::now();
+
+    // nothing on screen yet, the first update can't wait for a frame
+    if (!swipeState.sampled) {
+        swipeState.sampled    = true;
+        swipeState.delta      = delta;
+        swipeState.lastSample = NOW;
+        applySwipe(delta);
+        return;
+    }
+
+    const double DT = std::chrono::duration<double>(NOW - swipeState.lastSample).count();
+    if (DT > 0)
+        swipeState.velocity = 0.5 * swipeState.velocity + 0.5 * (delta - swipeState.delta) / DT;
+
+    swipeState.delta      = delta;
+    swipeState.lastSample = NOW;
+
+    if (!swipeState.pending) {
+        swipeState.pending = true;
+        g_pCompositor->scheduleFrameForMonitor(pMonitor.lock());
+    }
+}
+
+void COverview::applySwipe(double delta) {
     static auto* const* PDISTANCE = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:gesture_distance")->getDataStaticPtr();
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
 
@@ -431,8 +667,16 @@ void COverview::onSwipeUpdate(double delta) {
 }
 
 void COverview::onSwipeEnd() {
+    CTraceSpan span("COverview::onSwipeEnd");
+
     static auto* const* PCOLUMNS = (Hyprlang::INT* const*)HyprlandAPI::getConfigValue(PHANDLE, "plugin:winview:columns")->getDataStaticPtr();
-    
+
+    // land exactly where the finger stopped, not where we predicted it would go
+    if (swipeState.pending) {
+        swipeState.pending = false;
+        applySwipe(swipeState.delta);
+    }
+
     const auto SIZEMIN = pMonitor.lock()->m_size;
     int gridCols = **PCOLUMNS;
     const auto SIZEMAX = pMonitor.lock()->m_size * pMonitor.lock()->m_size / (pMonitor.lock()->m_size / gridCols);
@@ -444,7 +688,10 @@ void COverview::onSwipeEnd() {
     size->setValueAndWarp(pMonitor.lock()->m_size);
     pos->setValueAndWarp(Vector2D{0, 0});
 
-    size->setCallbackOnEnd([this](WP<Hyprutils::Animation::CBaseAnimatedVariable> thisptr) { redrawAll(true); });
+    size->setCallbackOnEnd([this](WP<Hyprutils::Animation::CBaseAnimatedVariable> thisptr) {
+        CTraceSpan span("anim:swipeCancelEnd");
+        redrawOutdated(true);
+    });
 
     swipeWasCommenced = true;
 }
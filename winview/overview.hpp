@@ -4,9 +4,10 @@
 
 #include "globals.hpp"
 #include <hyprland/src/desktop/DesktopTypes.hpp>
-#include <hyprland/src/render/Framebuffer.hpp>
+#include "CountedFramebuffer.hpp"
 #include <hyprland/src/helpers/AnimatedVariable.hpp>
 #include <hyprland/src/managers/HookSystemManager.hpp>
+#include <chrono>
 #include <vector>
 
 // saves on resources, but is a bit broken rn with blur.
@@ -14,6 +15,7 @@
 constexpr bool ENABLE_LOWRES = false;
 
 class CMonitor;
+struct wl_event_source;
 
 class COverview {
   public:
@@ -22,12 +24,14 @@ class COverview {
 
     void render();
     void damage();
-    void onDamageReported();
-    void onPreRender();
+    void onDamageReported(const CBox& box);
+    void onPreRender(PHLMONITOR pRenderMonitor);
 
     void onSwipeUpdate(double delta);
     void onSwipeEnd();
 
+    void onBackdropTimer();
+
     // close without a selection
     void          close();
     void          selectHoveredWindow();
@@ -39,9 +43,12 @@ class COverview {
 
   private:
     void       redrawID(int id, bool forcelowres = false);
-    void       redrawAll(bool forcelowres = false);
+    // every tile except undamaged ones borrowed from the resident cache
+    void       redrawOutdated(bool forcelowres = false);
     void       onWindowChange();
     void       fullRender();
+    void       renderBackdrop();
+    void       applySwipe(double delta);
 
     int        SIDE_LENGTH = 3;
     int        GAP_WIDTH   = 5;
@@ -49,11 +56,22 @@ class COverview {
 
     bool       damageDirty = false;
 
+    // blurred snapshot of the workspace under the overview, only redone once damage to it settles
+    CCountedFramebuffer                   backdropFB;
+    CCountedFramebuffer                   backdropWorkspaceFB;
+    bool                                  backdropDirty = false;
+    std::chrono::steady_clock::time_point backdropDirtySince;
+    wl_event_source*                      backdropTimer = nullptr;
+
     struct SWindowImage {
-        CFramebuffer fb;
-        PHLWINDOW    pWindow;
-        CBox         box;
-        Vector2D     position; // Grid position (col, row)
+        SP<CCountedFramebuffer> fb;
+        PHLWINDOW               pWindow;
+        CBox                    box;
+        Vector2D                position;      // Grid position (col, row)
+        bool                    stale    = false; // damaged since the last capture
+        bool                    rendered = false; // drawn during this session, so newer than any snapshot
+        // hidden or on another monitor, shown from the snapshot store instead of fb
+        SP<CTexture>            snapshot;
     };
 
     Vector2D                     lastMousePosLocal = Vector2D{};
@@ -71,6 +89,8 @@ class COverview {
 
     bool                         closing = false;
 
+    uint64_t                     traceSession = 0;
+
     SP<HOOK_CALLBACK_FN>         mouseMoveHook;
     SP<HOOK_CALLBACK_FN>         mouseButtonHook;
     SP<HOOK_CALLBACK_FN>         touchMoveHook;
@@ -79,6 +99,15 @@ class COverview {
     bool                         swipe             = false;
     bool                         swipeWasCommenced = false;
 
+    // swipe updates are coalesced and applied once per frame in onPreRender
+    struct {
+        bool                                  pending  = false;
+        bool                                  sampled  = false;
+        double                                delta    = 0;
+        double                                velocity = 0; // gesture units per second
+        std::chrono::steady_clock::time_point lastSample;
+    } swipeState;
+
     friend class COverviewPassElement;
 };
 
@@ -0,0 +1,180 @@
+#!/usr/bin/env bash
+# Opens and closes the overview in random ways (dispatcher, synthetic swipes) while windows
+# map, unmap and move around, under a headless Hyprland with the ASan build of the plugin.
+# After every iteration `hyprctl -j winview:fbstats` has to come back down: to 0 without
+# resident mode, and to at most one thumbnail per window (without growing) with it.
+#
+# usage: tests/stress.sh [iterations] [seed]
+# needs Hyprland, hyprctl, jq and a wayland client to spawn (WINVIEW_TEST_CLIENT, default foot)
+
+set -euo pipefail
+
+ITERATIONS=${1:-200}
+SEED=${2:-$RANDOM}
+CLIENT=${WINVIEW_TEST_CLIENT:-foot}
+MAX_CLIENTS=6
+
+HERE=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(dirname "$HERE")
+WORK=$(mktemp -d)
+HYPRPID=""
+
+cleanup() {
+    [[ -n $HYPRPID ]] && kill "$HYPRPID" 2>/dev/null && wait "$HYPRPID" 2>/dev/null
+    rm -rf "$WORK"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL (seed $SEED): $*" >&2
+    [[ -f $WORK/hyprland.log ]] && tail -n 40 "$WORK/hyprland.log" >&2
+    exit 1
+}
+
+echo "building the asan plugin"
+make -C "$ROOT" asan >/dev/null
+
+# resident and show_all_windows are only picked up on configReloaded, so it goes through the file and `hyprctl reload`
+write_config() {
+    cat >"$WORK/hyprland.conf" <<EOF
+monitor = , 1920x1080, auto, 1
+misc {
+    disable_hyprland_logo = true
+}
+plugin {
+    winview {
+        enable_gesture = 1
+        resident = $1
+        show_all_windows = $2
+    }
+}
+EOF
+}
+
+start_hyprland() {
+    export XDG_RUNTIME_DIR=${XDG_RUNTIME_DIR:-$WORK}
+    HYPRLAND_HEADLESS_ONLY=1 \
+        LD_PRELOAD=$(gcc -print-file-name=libasan.so) \
+        ASAN_OPTIONS="detect_leaks=0:abort_on_error=1:log_path=$WORK/asan" \
+        Hyprland --config "$WORK/hyprland.conf" >"$WORK/hyprland.log" 2>&1 &
+    HYPRPID=$!
+
+    for _ in $(seq 50); do
+        SIG=$(hyprctl instances -j 2>/dev/null | jq -r ".[] | select(.pid == $HYPRPID) | .instance" || true)
+        [[ -n $SIG ]] && break
+        sleep 0.2
+    done
+    [[ -n ${SIG:-} ]] || fail "Hyprland didn't come up"
+    export HYPRLAND_INSTANCE_SIGNATURE=$SIG
+
+    hyprctl output create headless >/dev/null
+    hyprctl plugin load "$ROOT/winview-asan.so" >/dev/null
+    hyprctl reload >/dev/null
+}
+
+clients() {
+    hyprctl -j clients | jq length
+}
+
+fbstat() {
+    hyprctl -j winview:fbstats | jq -r ".$1"
+}
+
+alive() {
+    kill -0 "$HYPRPID" 2>/dev/null || fail "Hyprland died"
+    compgen -G "$WORK/asan*" >/dev/null && fail "asan report: $(cat "$WORK"/asan*)"
+    return 0
+}
+
+swipe() {
+    # positive deltas open (gesture_positive defaults to 1), negative ones close
+    local dir=$1
+    hyprctl dispatch winview:debugswipe begin >/dev/null
+    for _ in $(seq $((RANDOM % 12 + 1))); do
+        hyprctl dispatch winview:debugswipe "update $((dir * (RANDOM % 80 + 1)))" >/dev/null
+    done
+    hyprctl dispatch winview:debugswipe end >/dev/null
+}
+
+random_action() {
+    case $((RANDOM % 10)) in
+    0) hyprctl dispatch winview:overview toggle ;;
+    1) hyprctl dispatch winview:overview on ;;
+    2) hyprctl dispatch winview:overview off ;;
+    3) hyprctl dispatch winview:overview select ;;
+    4) swipe 1 ;;
+    5) swipe -1 ;;
+    6) [[ $(clients) -lt $MAX_CLIENTS ]] && hyprctl dispatch exec "$CLIENT" ;;
+    7) hyprctl dispatch killactive ;;
+    8) hyprctl dispatch movetoworkspacesilent special ;;
+    9) hyprctl dispatch workspace $((RANDOM % 3 + 1)) ;;
+    esac >/dev/null || true
+}
+
+settle() {
+    hyprctl dispatch winview:overview off >/dev/null
+    # let the close animation finish and the overview get destroyed
+    sleep 0.6
+    for _ in $(seq 10); do
+        [[ $(fbstat overview) == false ]] && return
+        sleep 0.2
+    done
+    fail "overview didn't close"
+}
+
+run() {
+    local resident=$1
+    # snapshots must not keep anything on the gpu either once their readbacks are done
+    write_config "$resident" $((resident == 0 ? 1 : 0))
+    hyprctl reload >/dev/null
+    [[ $(fbstat resident) == $([[ $resident == 1 ]] && echo true || echo false) ]] || fail "resident=$resident didn't apply"
+    # thumbnails are column sized and the scratch buffer monitor sized, so the same number
+    # of windows has to end up at the same footprint every time
+    local -A seen=()
+
+    for i in $(seq "$ITERATIONS"); do
+        for _ in $(seq $((RANDOM % 6 + 1))); do
+            random_action
+            sleep 0.0$((RANDOM % 10))
+        done
+
+        settle
+        alive
+
+        local fbs bytes n
+        fbs=$(fbstat framebuffers)
+        bytes=$(fbstat bytes)
+        n=$(clients)
+
+        if [[ $resident == 0 ]]; then
+            # a snapshot refresh burst may still be running, give it a moment
+            for _ in $(seq 10); do
+                [[ $fbs == 0 && $bytes == 0 ]] && break
+                sleep 0.2
+                fbs=$(fbstat framebuffers)
+                bytes=$(fbstat bytes)
+            done
+            [[ $fbs == 0 && $bytes == 0 ]] || fail "iteration $i: $fbs framebuffers ($bytes bytes) left after closing"
+        else
+            # one thumbnail per window plus the refresh scratch buffer
+            ((fbs <= n + 1)) || fail "iteration $i: $fbs resident framebuffers for $n windows"
+            if [[ -z ${seen[$n]:-} ]] || ((bytes > seen[$n])); then
+                ((i < ITERATIONS / 4)) || [[ -z ${seen[$n]:-} ]] || fail "iteration $i: resident bytes grew to $bytes for $n windows (was ${seen[$n]})"
+                seen[$n]=$bytes
+            fi
+        fi
+    done
+}
+
+RANDOM=$SEED
+write_config 0 0
+start_hyprland
+for _ in $(seq 3); do hyprctl dispatch exec "$CLIENT" >/dev/null; done
+sleep 1
+
+echo "seed $SEED, $ITERATIONS iterations without resident, with snapshots"
+run 0
+echo "seed $SEED, $ITERATIONS iterations with resident"
+run 1
+
+echo "ok"